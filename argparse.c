@@ -20,12 +20,18 @@
 #include "argparse.h"
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <libmacro/assert.h>
 #include <libmacro/debug.h>
 #include <libstr/str.h>
 #include <libarray/array_str.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 
 void
 arg_parse_str(
@@ -71,6 +77,122 @@ arg_set_true(
 }
 
 
+#ifdef __SSE2__
+// Returns true if the 16 bytes at `s` are all ASCII, and, if `no_control`,
+// none of them are control characters.
+static
+bool
+is_clean_ascii_block(
+        unsigned char const * const s,
+        bool const no_control )
+{
+    __m128i const v = _mm_loadu_si128( ( __m128i const * ) s );
+    // Bytes of 0x80 and above are negative as signed chars:
+    __m128i bad = _mm_cmplt_epi8( v, _mm_setzero_si128() );
+    if ( no_control ) {
+        bad = _mm_or_si128( bad, _mm_cmplt_epi8( v, _mm_set1_epi8( 0x20 ) ) );
+        bad = _mm_or_si128( bad, _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x7F ) ) );
+    }
+    return _mm_movemask_epi8( bad ) == 0;
+}
+#endif
+
+
+// Returns the length of the well-formed UTF-8 sequence at the start of `s`,
+// which has `n` bytes, or `0` if it isn't well-formed. The code point is
+// written to `cp`.
+static
+size_t
+utf8_sequence(
+        unsigned char const * const s,
+        size_t const n,
+        ulong * const cp )
+{
+    unsigned char const c = s[ 0 ];
+    if ( c < 0x80 ) {
+        *cp = c;
+        return 1;
+    }
+    size_t length;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+    if ( c >= 0xC2 && c <= 0xDF ) {
+        length = 2;
+        *cp = c & 0x1F;
+    } else if ( c >= 0xE0 && c <= 0xEF ) {
+        length = 3;
+        *cp = c & 0x0F;
+        // Reject overlong encodings and surrogates:
+        if ( c == 0xE0 ) { lo = 0xA0; }
+        if ( c == 0xED ) { hi = 0x9F; }
+    } else if ( c >= 0xF0 && c <= 0xF4 ) {
+        length = 4;
+        *cp = c & 0x07;
+        // Reject overlong encodings and code points above U+10FFFF:
+        if ( c == 0xF0 ) { lo = 0x90; }
+        if ( c == 0xF4 ) { hi = 0x8F; }
+    } else {
+        return 0;
+    }
+    if ( length > n ) { return 0; }
+    for ( size_t i = 1; i < length; i++ ) {
+        if ( s[ i ] < lo || s[ i ] > hi ) { return 0; }
+        *cp = ( *cp << 6 ) | ( s[ i ] & 0x3F );
+        lo = 0x80;
+        hi = 0xBF;
+    }
+    return length;
+}
+
+
+// Returns true if `arg` passes the validation specified by `validate`;
+// otherwise, returns false and sets `offset` to the index of the first
+// offending byte.
+static
+bool
+validate_arg(
+        char const * const arg,
+        uint const validate,
+        size_t * const offset )
+{
+    ASSERT( arg != NULL, offset != NULL );
+
+    bool const utf8 = validate & ArgsValidate_UTF8;
+    bool const no_control = validate & ArgsValidate_NO_CONTROL;
+    if ( !utf8 && !no_control ) { return true; }
+    unsigned char const * const s = ( unsigned char const * ) arg;
+    size_t const n = strlen( arg );
+    size_t i = 0;
+    while ( i < n ) {
+      #ifdef __SSE2__
+        // Skip over blocks with nothing to check, then fall back to checking
+        // one character at a time until the next such block:
+        if ( n - i >= 16 && is_clean_ascii_block( s + i, no_control ) ) {
+            i += 16;
+            continue;
+        }
+      #endif
+        ulong cp = s[ i ];
+        size_t length = 1;
+        if ( utf8 ) {
+            length = utf8_sequence( s + i, n - i, &cp );
+            if ( length == 0 ) {
+                *offset = i;
+                return false;
+            }
+        }
+        if ( no_control
+          && ( cp < 0x20 || cp == 0x7F
+            || ( utf8 && cp >= 0x80 && cp <= 0x9F ) ) ) {
+            *offset = i;
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+
 static
 ArgFlag const *
 find_flag(
@@ -111,6 +233,390 @@ find_option(
 }
 
 
+// A sorted table of the flag and option names of a spec, for resolving
+// abbreviations by binary search:
+typedef struct argname {
+    char const * name;
+    ArgFlag const * flag;
+    ArgOption const * option;
+} ArgName;
+
+
+typedef struct argnames {
+    ArgName * e;
+    size_t length;
+} ArgNames;
+
+
+static
+int
+argname__compare(
+        void const * const va,
+        void const * const vb )
+{
+    ArgName const * const a = va;
+    ArgName const * const b = vb;
+    return strcmp( a->name, b->name );
+}
+
+
+static
+size_t
+count_names(
+        ArrayC_str const names,
+        char const * const name )
+{
+    return names.length + ( ( name != NULL ) ? 1 : 0 );
+}
+
+
+static
+void
+add_names(
+        ArgNames * const table,
+        ArrayC_str const names,
+        char const * const name,
+        ArgName const entry )
+{
+    for ( size_t i = 0; i < names.length; i++ ) {
+        ArgName e = entry;
+        e.name = names.e[ i ];
+        table->e[ table->length++ ] = e;
+    }
+    if ( name != NULL ) {
+        ArgName e = entry;
+        e.name = name;
+        table->e[ table->length++ ] = e;
+    }
+}
+
+
+// Returns false, with `errno` set, if the table couldn't be allocated.
+static
+bool
+argnames__from_spec(
+        ArgsSpec const spec,
+        ArgNames * const table )
+{
+    ASSERT( table != NULL );
+
+    size_t total = 0;
+    for ( size_t i = 0; i < spec.flags.length; i++ ) {
+        total += count_names( spec.flags.e[ i ].names,
+                              spec.flags.e[ i ].name );
+    }
+    for ( size_t i = 0; i < spec.options.length; i++ ) {
+        total += count_names( spec.options.e[ i ].names,
+                              spec.options.e[ i ].name );
+    }
+    *table = ( ArgNames ){ .e = NULL, .length = 0 };
+    if ( total == 0 ) { return true; }
+    table->e = malloc( total * sizeof *table->e );
+    if ( table->e == NULL ) { return false; }
+    for ( size_t i = 0; i < spec.flags.length; i++ ) {
+        ArgFlag const * const af = spec.flags.e + i;
+        add_names( table, af->names, af->name, ( ArgName ){ .flag = af } );
+    }
+    for ( size_t i = 0; i < spec.options.length; i++ ) {
+        ArgOption const * const ao = spec.options.e + i;
+        add_names( table, ao->names, ao->name, ( ArgName ){ .option = ao } );
+    }
+    ASSERT( table->length == total );
+    qsort( table->e, table->length, sizeof *table->e, argname__compare );
+    return true;
+}
+
+
+// Returns the index of the first name in the table not less than `prefix`.
+static
+size_t
+argnames__lower_bound(
+        ArgNames const table,
+        char const * const prefix )
+{
+    size_t lo = 0;
+    size_t hi = table.length;
+    while ( lo < hi ) {
+        size_t const mid = lo + ( hi - lo ) / 2;
+        if ( strcmp( table.e[ mid ].name, prefix ) < 0 ) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+static
+char *
+join_names(
+        ArgName const * const names,
+        size_t const length )
+{
+    size_t size = 1;
+    for ( size_t i = 0; i < length; i++ ) {
+        size += strlen( names[ i ].name ) + 2;
+    }
+    char * const joined = malloc( size );
+    if ( joined == NULL ) { return NULL; }
+    char * end = joined;
+    for ( size_t i = 0; i < length; i++ ) {
+        if ( i > 0 ) {
+            memcpy( end, ", ", 2 );
+            end += 2;
+        }
+        size_t const n = strlen( names[ i ].name );
+        memcpy( end, names[ i ].name, n );
+        end += n;
+    }
+    *end = '\0';
+    return joined;
+}
+
+
+// Returns the table entry that `arg` uniquely abbreviates, or `NULL` if it
+// doesn't abbreviate any name. If `arg` abbreviates the names of more than one
+// flag or option, this sets `err` to an `ArgsError_AMBIGUOUS_ARG` error.
+static
+ArgName const *
+find_abbreviation(
+        ArgNames const table,
+        char const * const arg,
+        ArgsError * const err )
+{
+    ASSERT( arg != NULL, err != NULL );
+
+    if ( strncmp( arg, "--", 2 ) != 0 || arg[ 2 ] == '\0' ) {
+        return NULL;
+    }
+    size_t const arg_length = strlen( arg );
+    size_t const first = argnames__lower_bound( table, arg );
+    size_t last = first;
+    bool ambiguous = false;
+    while ( last < table.length
+         && strncmp( table.e[ last ].name, arg, arg_length ) == 0 ) {
+        // Different names of the same flag or option aren't ambiguous:
+        if ( table.e[ last ].flag   != table.e[ first ].flag
+          || table.e[ last ].option != table.e[ first ].option ) {
+            ambiguous = true;
+        }
+        last++;
+    }
+    if ( first == last ) {
+        return NULL;
+    } else if ( ambiguous ) {
+        *err = ( ArgsError ){ .type = ArgsError_AMBIGUOUS_ARG,
+                              .str  = arg,
+                              .strm = join_names( table.e + first,
+                                                  last - first ) };
+        return NULL;
+    } else {
+        return table.e + first;
+    }
+}
+
+
+// A table of the feature names of a spec's flag families, sorted by family and
+// then by name, so each family's names can be found by binary search:
+typedef struct argfeature {
+    char const * name;
+    ArgFlagFamily const * family;
+    size_t bit;
+} ArgFeature;
+
+
+typedef struct argfeatures {
+    ArgFeature * e;
+    size_t length;
+} ArgFeatures;
+
+
+static
+int
+argfeature__compare_key(
+        ArgFlagFamily const * const family,
+        char const * const name,
+        ArgFeature const * const f )
+{
+    if ( family != f->family ) {
+        return ( family < f->family ) ? -1 : 1;
+    }
+    return strcmp( name, f->name );
+}
+
+
+static
+int
+argfeature__compare(
+        void const * const va,
+        void const * const vb )
+{
+    ArgFeature const * const a = va;
+    ArgFeature const * const b = vb;
+    return argfeature__compare_key( a->family, a->name, b );
+}
+
+
+static
+size_t
+family_num_bits(
+        ArgFlagFamily const * const family )
+{
+    return ( family->num_bits == 0 ) ? family->names.length
+                                     : family->num_bits;
+}
+
+
+// Returns false, with `errno` set, if the table couldn't be allocated.
+static
+bool
+argfeatures__from_spec(
+        ArgsSpec const spec,
+        ArgFeatures * const table )
+{
+    ASSERT( table != NULL );
+
+    size_t total = 0;
+    for ( size_t i = 0; i < spec.flag_families.length; i++ ) {
+        total += spec.flag_families.e[ i ].names.length;
+    }
+    *table = ( ArgFeatures ){ .e = NULL, .length = 0 };
+    if ( total == 0 ) { return true; }
+    table->e = malloc( total * sizeof *table->e );
+    if ( table->e == NULL ) { return false; }
+    for ( size_t i = 0; i < spec.flag_families.length; i++ ) {
+        ArgFlagFamily const * const ff = spec.flag_families.e + i;
+        ASSERT( ff->names.length <= family_num_bits( ff ) );
+        for ( size_t j = 0; j < ff->names.length; j++ ) {
+            table->e[ table->length++ ] = ( ArgFeature ){
+                .name   = ff->names.e[ j ],
+                .family = ff,
+                .bit    = j
+            };
+        }
+    }
+    qsort( table->e, table->length, sizeof *table->e, argfeature__compare );
+    return true;
+}
+
+
+static
+ArgFeature const *
+argfeatures__find(
+        ArgFeatures const table,
+        ArgFlagFamily const * const family,
+        char const * const name )
+{
+    size_t lo = 0;
+    size_t hi = table.length;
+    while ( lo < hi ) {
+        size_t const mid = lo + ( hi - lo ) / 2;
+        int const c = argfeature__compare_key( family, name, table.e + mid );
+        if ( c == 0 ) {
+            return table.e + mid;
+        } else if ( c < 0 ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+
+// Returns the portion of `arg` after `prefix`, or `NULL` if `arg` doesn't
+// start with `prefix` followed by at least one character.
+static
+char const *
+strip_prefix(
+        char const * const arg,
+        char const * const prefix )
+{
+    size_t const n = strlen( prefix );
+    if ( strncmp( arg, prefix, n ) != 0 || arg[ n ] == '\0' ) {
+        return NULL;
+    }
+    return arg + n;
+}
+
+
+// Returns true if `name` is a feature of `family`, and sets `bit` to its bit.
+static
+bool
+find_family_bit(
+        ArgFeatures const table,
+        ArgFlagFamily const * const family,
+        char const * const name,
+        size_t * const bit )
+{
+    ArgFeature const * const f = argfeatures__find( table, family, name );
+    if ( f != NULL ) {
+        *bit = f->bit;
+        return true;
+    }
+    int const index = ( family->index != NULL ) ? family->index( name ) : -1;
+    if ( index >= 0 && ( size_t ) index < family_num_bits( family ) ) {
+        *bit = index;
+        return true;
+    }
+    return false;
+}
+
+
+// Returns the family that `arg` enables or disables a feature of, or `NULL`
+// if there is no such family.
+static
+ArgFlagFamily const *
+find_feature(
+        ArgFeatures const table,
+        ArrayC_ArgFlagFamily const families,
+        char const * const arg,
+        size_t * const bit,
+        bool * const enable )
+{
+    ASSERT( arg != NULL, bit != NULL, enable != NULL );
+
+    for ( size_t i = 0; i < families.length; i++ ) {
+        ArgFlagFamily const * const ff = families.e + i;
+        char const * const prefixes[ 2 ] = {
+            ff->enable_prefix  ? ff->enable_prefix  : "--enable-",
+            ff->disable_prefix ? ff->disable_prefix : "--disable-"
+        };
+        // Try the longer prefix first, in case the other is a prefix of it:
+        bool const disable_first = strlen( prefixes[ 1 ] )
+                                 > strlen( prefixes[ 0 ] );
+        for ( size_t j = 0; j < 2; j++ ) {
+            *enable = ( j == 0 ) != disable_first;
+            char const * const name = strip_prefix( arg,
+                                                    prefixes[ !*enable ] );
+            if ( name != NULL && find_family_bit( table, ff, name, bit ) ) {
+                return ff;
+            }
+        }
+    }
+    return NULL;
+}
+
+
+static
+void
+set_bit(
+        ulong * const bits,
+        size_t const bit,
+        bool const value )
+{
+    ASSERT( bits != NULL );
+
+    ulong const mask = 1UL << ( bit % ARG_BITS_PER_WORD );
+    if ( value ) {
+        bits[ bit / ARG_BITS_PER_WORD ] |= mask;
+    } else {
+        bits[ bit / ARG_BITS_PER_WORD ] &= ~mask;
+    }
+}
+
+
 static
 bool
 over_or_eq_max(
@@ -159,15 +665,15 @@ argparse(
 }
 
 
+static
 void
-argparse_array(
+parse_args(
         ArrayC_str const args,
         ArgsError * const err,
-        ArgsSpec const spec )
+        ArgsSpec const spec,
+        ArgNames const names,
+        ArgFeatures const features )
 {
-    ASSERT( arrayc_str__is_valid( args ), err != NULL );
-
-    *err = ( ArgsError ){ .type = ArgsError_NONE };
     size_t num_positionals = 0;
     // Positional parsing state:
     ArgPositional const * positional = NULL;
@@ -209,11 +715,38 @@ argparse_array(
             option_name = NULL;
         }
         preserve_option = false;
+        // Find the flag or option that our argument names:
+        char const * name = arg;
+        ArgFlag const * flag = find_flag( spec.flags, arg );
+        ArgOption const * new_option = ( flag == NULL )
+                                     ? find_option( spec.options, arg )
+                                     : NULL;
+        // Or, if our argument enables or disables a feature of a flag family:
+        if ( flag == NULL && new_option == NULL ) {
+            size_t bit = 0;
+            bool enable = false;
+            ArgFlagFamily const * const family = find_feature(
+                features, spec.flag_families, arg, &bit, &enable );
+            if ( family != NULL ) {
+                set_bit( family->destination, bit, enable );
+                if ( family->stop ) { return; }
+                continue;
+            }
+        }
+        // Or, the flag or option that our argument abbreviates:
+        if ( flag == NULL && new_option == NULL && spec.abbreviations ) {
+            ArgName const * const an = find_abbreviation( names, arg, err );
+            if ( err->type != ArgsError_NONE ) { return; }
+            if ( an != NULL ) {
+                name = an->name;
+                flag = an->flag;
+                new_option = an->option;
+            }
+        }
         // If our argument matches a flag name:
-        ArgFlag const * const flag = find_flag( spec.flags, arg );
         if ( flag != NULL ) {
             ( flag->parser ? flag->parser : arg_set_true )
-                ( arg, NULL, flag->destination );
+                ( name, NULL, flag->destination );
             if ( errno ) {
                 *err = ( ArgsError ){ .type  = ArgsError_PARSE_ARG,
                                       .error = errno,
@@ -224,7 +757,6 @@ argparse_array(
             continue;
         }
         // Or, if our argument matches an option name:
-        ArgOption const * const new_option = find_option( spec.options, arg );
         if ( new_option != NULL ) {
             if ( option != NULL
               && under_min( option->num_args, option_arg_count ) ) {
@@ -233,13 +765,21 @@ argparse_array(
                 return;
             }
             option = new_option;
-            option_name = arg;
+            option_name = name;
             option_arg_count = 0;
             preserve_option = true;
             continue;
         }
         // Or, if we're parsing option arguments:
         if ( option != NULL ) {
+            size_t offset = 0;
+            if ( !validate_arg( arg, option->validate, &offset ) ) {
+                *err = ( ArgsError ){ .type   = ArgsError_PARSE_ARG,
+                                      .error  = EILSEQ,
+                                      .str    = arg,
+                                      .offset = offset };
+                return;
+            }
             ( option->parser ? option->parser : arg_parse_str )
                 ( option_name, arg, option->destination );
             if ( errno ) {
@@ -256,6 +796,14 @@ argparse_array(
         // Or, if we have outstanding positional arguments:
         if ( num_positionals < spec.positionals.length ) {
             positional = spec.positionals.e + num_positionals;
+            size_t offset = 0;
+            if ( !validate_arg( arg, positional->validate, &offset ) ) {
+                *err = ( ArgsError ){ .type   = ArgsError_PARSE_ARG,
+                                      .error  = EILSEQ,
+                                      .str    = arg,
+                                      .offset = offset };
+                return;
+            }
             ( positional->parser ? positional->parser : arg_parse_str )
                 ( positional->name, arg, positional->destination );
             if ( errno ) {
@@ -304,6 +852,45 @@ argparse_array(
 }
 
 
+void
+argparse_array(
+        ArrayC_str const args,
+        ArgsError * const err,
+        ArgsSpec const spec )
+{
+    ASSERT( arrayc_str__is_valid( args ), err != NULL );
+
+    *err = ( ArgsError ){ .type = ArgsError_NONE };
+    ArgNames names = { .e = NULL, .length = 0 };
+    if ( spec.abbreviations && !argnames__from_spec( spec, &names ) ) {
+        *err = ( ArgsError ){ .type  = ArgsError_SYSTEM,
+                              .error = errno };
+        return;
+    }
+    ArgFeatures features;
+    if ( !argfeatures__from_spec( spec, &features ) ) {
+        *err = ( ArgsError ){ .type  = ArgsError_SYSTEM,
+                              .error = errno };
+        free( names.e );
+        return;
+    }
+    parse_args( args, err, spec, names, features );
+    free( features.e );
+    free( names.e );
+}
+
+
+void
+argserror__free(
+        ArgsError * const err )
+{
+    ASSERT( err != NULL );
+
+    free( err->strm );
+    err->strm = NULL;
+}
+
+
 char const *
 argserrortype__to_str(
         enum ArgsErrorType const t )
@@ -317,6 +904,7 @@ argserrortype__to_str(
         case ArgsError_MISSING_OPTION_ARG: return "missing option argument";
         case ArgsError_INCONSISTENT_ARG:   return "inconsistent argument";
         case ArgsError_SYSTEM:             return "system error";
+        case ArgsError_AMBIGUOUS_ARG:      return "ambiguous argument";
         default:                           return "unknown error type";
     }
 }
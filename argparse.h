@@ -52,6 +52,10 @@ argparse_array( ArrayC_str args,
                 ArgsSpec spec );
 
 
+void
+argserror__free( ArgsError * err );
+
+
 char const *
 argserrortype__to_str( enum ArgsErrorType );
 
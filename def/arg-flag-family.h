@@ -0,0 +1,65 @@
+
+// Copyright 2015  Malcolm Inglis <http://minglis.id.au>
+//
+// This file is part of Libargs.
+//
+// Libargs is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// Libargs is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with Libargs. If not, see <https://gnu.org/licenses/>.
+
+
+#ifndef LIBARGS_DEF_ARGFLAGFAMILY_H
+#define LIBARGS_DEF_ARGFLAGFAMILY_H
+
+
+#include <limits.h>
+#include <stddef.h>
+
+#include <libtypes/types.h>
+#include <libarray/def/array_str.h>
+
+
+typedef struct argflagfamily {
+    char const * enable_prefix;
+    char const * disable_prefix;
+    ArrayC_str names;
+    int ( * index )( char const * name );
+    ulong * destination;
+    size_t num_bits;
+    bool stop;
+} ArgFlagFamily;
+
+// A flag family matches any argument of the form `<enable_prefix><name>` or
+// `<disable_prefix><name>`, and sets or clears bit `i` of the `destination`
+// bitset, where `i` is the index of `name` in `names`. If `name` isn't in
+// `names`, and `index` isn't `NULL`, then `i` is `index( name )`; an index
+// that's negative, or not less than `num_bits`, means that `name` isn't in the
+// family. The prefixes default to `--enable-` and `--disable-` if they're
+// `NULL`. If `arg` starts with both prefixes (e.g. with `--` and `--no-`), the
+// longer prefix is tried first, and the shorter is only tried if that doesn't
+// give a name in the family.
+//
+// `num_bits` is the number of bits in `destination`, and must be at least
+// `names.length`; if it's `0`, it's taken to be `names.length`. Bit `i` is bit
+// `i % ARG_BITS_PER_WORD` of word `i / ARG_BITS_PER_WORD`, so `destination`
+// must have at least `ARG_BITS_WORDS( num_bits )` words.
+
+// @public
+#define ARG_BITS_PER_WORD ( CHAR_BIT * sizeof ( ulong ) )
+
+// @public
+#define ARG_BITS_WORDS( N ) \
+    ( ( ( N ) + ARG_BITS_PER_WORD - 1 ) / ARG_BITS_PER_WORD )
+
+
+#endif // ifndef LIBARGS_DEF_ARGFLAGFAMILY_H
+
@@ -25,6 +25,7 @@
 #include <libarray/def/array_str.h>
 
 #include "args-num.h"
+#include "args-validate.h"
 
 
 typedef struct argoption {
@@ -37,6 +38,7 @@ typedef struct argoption {
                        char const * arg,
                        void * destination );
     bool stop;
+    uint validate;
 } ArgOption;
 
 
@@ -21,7 +21,10 @@
 #define LIBARGS_DEF_ARGPOSITIONAL_H
 
 
+#include <libtypes/types.h>
+
 #include "args-num.h"
+#include "args-validate.h"
 
 
 typedef struct argpositional {
@@ -31,6 +34,7 @@ typedef struct argpositional {
     void ( * parser )( char const * name,
                        char const * arg,
                        void * destination );
+    uint validate;
 } ArgPositional;
 
 
@@ -21,6 +21,9 @@
 #define LIBARGS_DEF_ARGSERROR_H
 
 
+#include <stddef.h>
+
+
 enum ArgsErrorType {
     ArgsError_NONE = 0,
     ArgsError_ERROR,
@@ -29,7 +32,8 @@ enum ArgsErrorType {
     ArgsError_UNKNOWN_ARG,
     ArgsError_MISSING_OPTION_ARG,
     ArgsError_INCONSISTENT_ARG,
-    ArgsError_SYSTEM
+    ArgsError_SYSTEM,
+    ArgsError_AMBIGUOUS_ARG
 };
 
 
@@ -38,8 +42,17 @@ typedef struct argserror {
     int error;
     char const * str;
     char * strm;
+    size_t offset;
 } ArgsError;
 
+// For `ArgsError_AMBIGUOUS_ARG`, `str` is the given argument, and `strm` is
+// an allocated, comma-separated list of the names it could abbreviate (or
+// `NULL` if that list couldn't be allocated). Use `argserror__free` to free
+// it.
+//
+// For an `ArgsError_PARSE_ARG` from validating an argument, `offset` is the
+// index in `str` of the first offending byte.
+
 
 #endif // ifndef LIBARGS_DEF_ARGSERROR_H
 
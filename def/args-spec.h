@@ -21,17 +21,26 @@
 #define LIBARGS_DEF_ARGSSPEC_H
 
 
+#include <libtypes/types.h>
 #include <libarray/def/array_arg-positional.h>
 #include <libarray/def/array_arg-flag.h>
 #include <libarray/def/array_arg-option.h>
+#include <libarray/def/array_arg-flag-family.h>
 
 
 typedef struct argsspec {
     ArrayC_ArgPositional positionals;
     ArrayC_ArgFlag flags;
     ArrayC_ArgOption options;
+    ArrayC_ArgFlagFamily flag_families;
+    bool abbreviations;
 } ArgsSpec;
 
+// If `abbreviations` is true, an argument beginning with `--` that doesn't
+// exactly match a flag or option will be taken as an abbreviation of the
+// `names` or `name` that it uniquely prefixes. The `pattern` functions aren't
+// considered for abbreviations.
+
 
 #endif // ifndef LIBARGS_DEF_ARGSSPEC_H
 
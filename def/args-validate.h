@@ -0,0 +1,40 @@
+
+// Copyright 2015  Malcolm Inglis <http://minglis.id.au>
+//
+// This file is part of Libargs.
+//
+// Libargs is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Affero General Public License as published by the
+// Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+//
+// Libargs is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for
+// more details.
+//
+// You should have received a copy of the GNU Affero General Public License
+// along with Libargs. If not, see <https://gnu.org/licenses/>.
+
+
+#ifndef LIBARGS_DEF_ARGSVALIDATE_H
+#define LIBARGS_DEF_ARGSVALIDATE_H
+
+
+// Flags for the `validate` fields of `ArgOption` and `ArgPositional`:
+enum {
+    ArgsValidate_NONE       = 0,
+    ArgsValidate_UTF8       = 1 << 0,
+    ArgsValidate_NO_CONTROL = 1 << 1
+};
+
+// `ArgsValidate_UTF8` rejects arguments that aren't well-formed UTF-8.
+// `ArgsValidate_NO_CONTROL` rejects arguments containing an ASCII control
+// character (or, with `ArgsValidate_UTF8`, a C1 control character). An
+// argument is validated before it's given to the parser, and a rejected
+// argument results in an `ArgsError_PARSE_ARG` error, with `error` as
+// `EILSEQ` and `offset` as the index of the first offending byte.
+
+
+#endif // ifndef LIBARGS_DEF_ARGSVALIDATE_H
+
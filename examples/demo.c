@@ -88,5 +88,6 @@ main( int const argc,
         }
         printf( "\nPass `--help` to see usage.\n" );
     }
+    argserror__free( &err );
 }
 